@@ -1,5 +1,5 @@
-cl /I d:\jdk1.3\include /I d:\jdk1.3\include\win32 -c jshortcut.cpp
+cl /MT /I d:\jdk1.3\include /I d:\jdk1.3\include\win32 -c jshortcut.cpp lnkcheck.cpp
 
-link /nologo /incremental:no /fixed:no /nod /dll /release /machine:ix86 /out:..\..\jshortcut.dll /def:jshortcut.def jshortcut.obj advapi32.lib shell32.lib ole32.lib uuid.lib libcmt.lib kernel32.lib 
+link /nologo /incremental:no /fixed:no /nod /dll /release /machine:ix86 /out:..\..\jshortcut.dll /def:jshortcut.def jshortcut.obj lnkcheck.obj advapi32.lib shell32.lib ole32.lib uuid.lib libcmt.lib kernel32.lib 
 
 erase ..\..\jshortcut.exp ..\..\jshortcut.lib
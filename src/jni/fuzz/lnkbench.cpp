@@ -0,0 +1,315 @@
+/* Copyright 2026 the JShortcut contributors under GNU LGPL v2.1 */
+
+// Throughput benchmark for the shortcut file validator.
+//
+//   lnkbench [file.lnk ...]	time validating each file (or a built-in
+//				sample shortcut if no files are given)
+//   lnkbench -w file.lnk	write the built-in sample shortcut, for
+//				use as a fuzzing seed
+//
+// Everywhere this times JShortcutValidateLink on the file contents in
+// memory.  On Windows it also times the whole of
+// JShortcutValidateLinkFile as JShellLink.load() uses it, including
+// opening, sizing, mapping and closing the file, and loading the file
+// through IPersistFile::Load, and reports the first as a percentage of
+// the second.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "lnkcheck.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <shlobj.h>
+#include <objidl.h>
+#endif
+
+// A shortcut to C:\x\y.exe with an IDList, a LinkInfo, a working
+// directory, arguments and a TrackerDataBlock.
+static unsigned char sample[512];
+static unsigned int sampleLen;
+
+static void
+put16(unsigned int x)
+{
+	sample[sampleLen++] = x & 0xff;
+	sample[sampleLen++] = (x>>8) & 0xff;
+}
+
+static void
+put32(unsigned int x)
+{
+	put16(x & 0xffff);
+	put16(x>>16);
+}
+
+static void
+putStr(const char *s)
+{
+	do {
+		sample[sampleLen++] = *s;
+	} while (*s++);
+}
+
+static void
+putUnicode(const char *s)
+{
+	put16(strlen(s));
+	for (; *s; s++)
+		put16((unsigned char)*s);
+}
+
+static void
+makeSample()
+{
+	static const unsigned char clsid[16] = {
+		0x01, 0x14, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46
+	};
+	unsigned int info, vol, i;
+
+	// ShellLinkHeader: IDList, LinkInfo, WorkingDir, Arguments, Unicode
+	put32(JSHORTCUT_LINK_HEADER_SIZE);
+	memcpy(sample+sampleLen,clsid,sizeof(clsid));
+	sampleLen += sizeof(clsid);
+	put32(0x01|0x02|0x10|0x20|0x80);
+	sampleLen = JSHORTCUT_LINK_HEADER_SIZE;
+
+	// LinkTargetIDList: one 20-byte ItemID and the TerminalID
+	put16(22);
+	put16(20);
+	for (i=0; i<18; i++)
+		sample[sampleLen++] = 'a';
+	put16(0);
+
+	// LinkInfo with a VolumeID, LocalBasePath and CommonPathSuffix
+	info = sampleLen;
+	put32(0);		// LinkInfoSize, filled in below
+	put32(0x1C);		// LinkInfoHeaderSize
+	put32(1);		// VolumeIDAndLocalBasePath
+	put32(0x1C);		// VolumeIDOffset
+	put32(0);		// LocalBasePathOffset, filled in below
+	put32(0);		// CommonNetworkRelativeLinkOffset
+	put32(0);		// CommonPathSuffixOffset, filled in below
+	vol = sampleLen;
+	put32(0);		// VolumeIDSize, filled in below
+	put32(3);		// DRIVE_FIXED
+	put32(0x1234);		// DriveSerialNumber
+	put32(0x10);		// VolumeLabelOffset
+	putStr("VOL");
+	sample[vol] = sampleLen-vol;
+	sample[info+16] = sampleLen-info;
+	putStr("C:\\x\\y.exe");
+	sample[info+24] = sampleLen-info;
+	putStr("");
+	sample[info] = sampleLen-info;
+
+	// StringData
+	putUnicode("C:\\x");
+	putUnicode("-v");
+
+	// ExtraData: a TrackerDataBlock and the TerminalBlock
+	put32(0x60);
+	put32(0xA0000003);
+	for (i=0; i<0x58; i++)
+		sample[sampleLen++] = 0;
+	put32(0);
+}
+
+static unsigned char*
+readFile(
+	const char *fileName,
+	unsigned int *lenp)
+{
+	FILE *f;
+	long len;
+	unsigned char *data;
+
+	f = fopen(fileName,"rb");
+	if (!f)
+		return NULL;
+	fseek(f,0,SEEK_END);
+	len = ftell(f);
+	fseek(f,0,SEEK_SET);
+	if (len<0 || len>JSHORTCUT_MAX_LINK_SIZE) {
+		fclose(f);
+		return NULL;
+	}
+	data = (unsigned char*)malloc(len ? len : 1);
+	if (data && fread(data,1,len,f)!=(size_t)len) {
+		free(data);
+		data = NULL;
+	}
+	fclose(f);
+	*lenp = (unsigned int)len;
+	return data;
+}
+
+// Time the validator on one file.
+static double		// seconds per call
+timeValidate(
+	const unsigned char *data,
+	unsigned int len,
+	const char **errStrp)	// RETURN the validator's result
+{
+	long iterations = 1000;
+	long i;
+	clock_t start, elapsed;
+
+	for (;;) {
+		start = clock();
+		for (i=0; i<iterations; i++)
+			*errStrp = JShortcutValidateLink(data,len);
+		elapsed = clock()-start;
+		if (elapsed >= CLOCKS_PER_SEC/2 || iterations > 1000000000L/4)
+			break;
+		iterations *= 4;
+	}
+	return (double)elapsed/CLOCKS_PER_SEC/iterations;
+}
+
+#ifdef _WIN32
+// Time checking one file as JShellLink.load() does before loading it.
+static double		// seconds per call
+timeValidateFile(
+	const char *fileName,
+	const char **errStrp)	// RETURN the validator's result
+{
+	HANDLE hFile;
+	long iterations = 100;
+	long i;
+	clock_t start, elapsed;
+
+	for (;;) {
+		start = clock();
+		for (i=0; i<iterations; i++) {
+			*errStrp = JShortcutValidateLinkFile(fileName,&hFile);
+			if (*errStrp==NULL)
+				CloseHandle(hFile);
+		}
+		elapsed = clock()-start;
+		if (elapsed >= CLOCKS_PER_SEC/2 || iterations > 1000000L)
+			break;
+		iterations *= 4;
+	}
+	return (double)elapsed/CLOCKS_PER_SEC/iterations;
+}
+
+// Time loading one file through the shell, as JShellLink.load() does.
+static double		// seconds per call, or 0 if the shell can't load it
+timeShellLoad(
+	const char *fileName)
+{
+	IShellLink *shellLink = NULL;
+	IPersistFile *persistFile = NULL;
+	WCHAR wName[MAX_PATH+1];
+	long iterations = 100;
+	long i;
+	clock_t start, elapsed = 0;
+	double result = 0;
+
+	MultiByteToWideChar(CP_ACP,0,fileName,-1,wName,MAX_PATH);
+	if (FAILED(CoCreateInstance(CLSID_ShellLink, NULL,
+			CLSCTX_INPROC_SERVER, IID_IShellLink,
+			(PVOID*)&shellLink)))
+		return 0;
+	if (FAILED(shellLink->QueryInterface(IID_IPersistFile,
+			(PVOID*)&persistFile))) {
+		shellLink->Release();
+		return 0;
+	}
+	for (;;) {
+		start = clock();
+		for (i=0; i<iterations; i++) {
+			if (FAILED(persistFile->Load(wName,0)))
+				goto done;
+		}
+		elapsed = clock()-start;
+		if (elapsed >= CLOCKS_PER_SEC/2 || iterations > 1000000L)
+			break;
+		iterations *= 4;
+	}
+	result = (double)elapsed/CLOCKS_PER_SEC/iterations;
+done:
+	persistFile->Release();
+	shellLink->Release();
+	return result;
+}
+#endif
+
+static void
+report(
+	const char *label,
+	const unsigned char *data,
+	unsigned int len,
+	const char *fileName)	// NULL for the built-in sample
+{
+	const char *errStr;
+	double t;
+
+	t = timeValidate(data,len,&errStr);
+	printf("%s: %u bytes, %s, in memory %.0f ns/file, %.0f MB/s",
+		label,len,errStr ? errStr : "valid",
+		t*1e9,len/t/1e6);
+#ifdef _WIN32
+	if (fileName!=NULL) {
+		double file = timeValidateFile(fileName,&errStr);
+		printf(", from file %.0f ns/file",file*1e9);
+		if (errStr==NULL) {
+			double shell = timeShellLoad(fileName);
+			if (shell > 0)
+				printf(", shell load %.0f ns/file, "
+					"validation %.2f%% of load",
+					shell*1e9,100*file/shell);
+		}
+	}
+#else
+	(void)fileName;
+#endif
+	printf("\n");
+}
+
+int
+main(
+	int argc,
+	char **argv)
+{
+	int i;
+	int status = 0;
+
+	makeSample();
+
+	if (argc==3 && strcmp(argv[1],"-w")==0) {
+		FILE *f = fopen(argv[2],"wb");
+		if (!f || fwrite(sample,1,sampleLen,f)!=sampleLen ||
+		    fclose(f)!=0) {
+			fprintf(stderr,"Can't write %s\n",argv[2]);
+			return 1;
+		}
+		return 0;
+	}
+
+#ifdef _WIN32
+	CoInitialize(NULL);
+#endif
+	if (argc<2)
+		report("sample",sample,sampleLen,NULL);
+	for (i=1; i<argc; i++) {
+		unsigned int len;
+		unsigned char *data = readFile(argv[i],&len);
+
+		if (!data) {
+			fprintf(stderr,"Can't read %s\n",argv[i]);
+			status = 1;
+			continue;
+		}
+		report(argv[i],data,len,argv[i]);
+		free(data);
+	}
+#ifdef _WIN32
+	CoUninitialize();
+#endif
+	return status;
+}
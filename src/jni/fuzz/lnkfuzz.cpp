@@ -0,0 +1,20 @@
+/* Copyright 2026 the JShortcut contributors under GNU LGPL v2.1 */
+
+// libFuzzer target for the shortcut file validator.
+// Build with "make lnkfuzz" and run with "make runfuzz" in this directory.
+
+#include <stddef.h>
+#include <stdint.h>
+#include "lnkcheck.h"
+
+extern "C" int
+LLVMFuzzerTestOneInput(
+	const uint8_t *data,
+	size_t size)
+{
+	// JShortcutValidateLinkFile never passes anything larger than this
+	if (size > JSHORTCUT_MAX_LINK_SIZE)
+		return 0;
+	JShortcutValidateLink(data,(unsigned int)size);
+	return 0;
+}
@@ -3,7 +3,13 @@
 #include <windows.h>
 #include <shlobj.h>
 #include <objidl.h>
+#include <process.h>
 #include <jni.h>
+#include "lnkcheck.h"
+
+#ifndef INVALID_FILE_ATTRIBUTES
+#define INVALID_FILE_ATTRIBUTES ((DWORD)-1)	//not in older SDKs
+#endif
 
 //Define this to use UTF-8 encoding of native strings.  If the native encoding
 //may not be UTF-8, leave this undefined to use the native encoding.
@@ -40,6 +46,30 @@ JShortcutInitContext(struct eContext* ctx, JNIEnv *env, jobject jobj) {
 	ctx->jobj = jobj;
 }
 
+//Look up the classes which the helpers below would otherwise look up and
+//cache on first use.  A JNI call which loops with PushLocalFrame and
+//PopLocalFrame must call this before the loop, since a class found inside
+//a local frame is freed when that frame is popped.
+static
+int			// 0 if error, 1 if OK
+JShortcutFindClasses(struct eContext* ctx) {
+	char *className;
+
+	className = "net/jimmc/jshortcut/JShellLink";
+	ctx->JShellLinkClass = ctx->env->FindClass(className);
+	if (!ctx->JShellLinkClass) {
+		fprintf(stderr,"Can't find class %s\n",className);
+		return 0;
+	}
+	className = "java/lang/String";
+	ctx->StringClass = ctx->env->FindClass(className);
+	if (!ctx->StringClass) {
+		fprintf(stderr,"Can't find class %s\n",className);
+		return 0;
+	}
+	return 1;
+}
+
 // Given a Java string, convert it to a native string
 static
 char*
@@ -183,6 +213,52 @@ JShortcutGetNativeString(
 	return JShortcutJavaStringToNative(ctx,fieldValue,jfreeobjp);
 }
 
+// Get a JShellLink object String field in the ANSI code page, whatever
+// the JVM's default encoding is.  Characters which are not in the code
+// page are replaced with the system default character.
+static
+int			// 0 if error or null, 1 if OK
+JShortcutGetAcpString(
+	struct eContext *ctx,
+	char *fieldName,	// the name of the String field to get
+	char *buf,		// RETURN the string
+	int bufSize)		// size of buf
+{
+	jfieldID fid;
+	jstring fieldValue;
+	const jchar *chars;
+	int len;
+
+	buf[0] = 0;
+	if (!ctx->JShellLinkClass) {
+		char *className = "net/jimmc/jshortcut/JShellLink";
+		ctx->JShellLinkClass = ctx->env->FindClass(className);
+		if (!ctx->JShellLinkClass) {
+			fprintf(stderr,"Can't find class %s\n",className);
+			return 0;
+		}
+	}
+	fid = ctx->env->GetFieldID(ctx->JShellLinkClass,fieldName,stringType);
+	if (fid==0) {
+		fprintf(stderr,"Can't find field %s\n",fieldName);
+		return 0;
+	}
+	fieldValue = (jstring)ctx->env->GetObjectField(ctx->jobj,fid);
+	if (!fieldValue)
+		return 0;
+	len = ctx->env->GetStringLength(fieldValue);
+	chars = ctx->env->GetStringChars(fieldValue,NULL);
+	if (!chars)
+		return 0;
+	len = len ? WideCharToMultiByte(CP_ACP,0,(LPCWSTR)chars,len,
+			buf,bufSize-1,NULL,NULL) : 0;
+	ctx->env->ReleaseStringChars(fieldValue,chars);
+	if (len==0 && ctx->env->GetStringLength(fieldValue)!=0)
+		return 0;		// too long for buf
+	buf[len] = 0;
+	return 1;
+}
+
 // Set a Java string value into a JShellLink object.
 static
 int			// 0 if error, 1 if OK
@@ -333,6 +409,94 @@ JShortcutGetRegistryValue(
 	return 0;
 }
 
+// Build the full file name of a shortcut from its folder and base name.
+static
+int			// 0 if error, 1 if OK
+JShortcutLinkFileName(
+	char *buf,		// RETURN the file name
+	int bufSize,		// size of buf
+	const char *folder,	// The directory containing the shortcut
+	const char *name,	// Base name of the shortcut
+	const char *suffix)	// Appended after ".lnk", or NULL
+{
+	if (suffix==NULL)
+		suffix = "";
+	buf[0] = 0;
+	if (strlen(folder)+strlen(name)+strlen(suffix)+6 > (size_t)bufSize)
+		return 0;
+	strcat(buf,folder);
+	strcat(buf,"\\");
+	strcat(buf,name);
+	strcat(buf,".lnk");
+	strcat(buf,suffix);
+	return 1;
+}
+
+// Save a shell link using an already-created IShellLink.
+// The values in loadFile (if it exists and is well-formed) are used for
+// anything the application has not set, and the result is written to
+// saveFile.
+static
+HRESULT			// status: test using FAILED or SUCCEEDED macro
+JShortcutSaveLink(	// Save a shortcut from an existing IShellLink
+	IShellLink *shellLink,
+	IPersistFile *persistFile,	// IPersistFile of shellLink
+	const char *loadFile,	// The existing shortcut file to start from
+	const char *saveFile,	// The shortcut file to write
+	const char *description,// Description of the shortcut
+	const char *path,	// Path to the target of the link
+	const char *args,	// Arguments for the target of the link
+	const char *workingDir,	// Working directory for the shortcut
+	const char *iconLoc,	// Path to file containing icon
+	const int iconIndex,	// Index of icon within the icon file
+	const char **errStrp	// RETURN description of the error, if any
+)
+{
+	HRESULT h;
+	HANDLE hFile;
+	const char *errStr;
+#ifdef _WIN64
+        wchar_t wName[MAX_PATH+1];
+#else
+	WORD wName[MAX_PATH+1];
+#endif
+
+	// Load the file if it exists, to get the values for anything
+	// that we do not set.  A file which is malformed or can't be read
+	// is not loaded, and is replaced by a new shortcut with only the
+	// values which the application has set.
+	errStr = JShortcutValidateLinkFile(loadFile,&hFile);
+	if (errStr==NULL) {
+		MultiByteToWideChar(CP_ACP,0,loadFile,-1,wName,MAX_PATH);
+		h = persistFile->Load(wName, 0);
+		CloseHandle(hFile);
+	} else if (errStr!=JShortcutLinkNotFound) {
+		fprintf(stderr,"Warning: replacing %s: %s\n",loadFile,errStr);
+	}
+
+	// Set the fields for which the application has set a value
+	if (description!=NULL)
+		shellLink->SetDescription(description);
+	if (path!=NULL)
+		shellLink->SetPath(path);
+	if (args!=NULL)
+		shellLink->SetArguments(args);
+	if (workingDir!=NULL)
+		shellLink->SetWorkingDirectory(workingDir);
+	if (iconLoc!=NULL)
+		shellLink->SetIconLocation(iconLoc,iconIndex);
+
+	//One example elsewhere adds this line:
+	//shellLink->SetShowCommand(SW_SHOW);
+
+	//Save the shortcut to disk
+	MultiByteToWideChar(CP_ACP,0,saveFile,-1,wName,MAX_PATH);
+	h = persistFile->Save(wName, TRUE);
+	if (FAILED(h))
+		*errStrp = "Failed to save shortcut";
+	return h;
+}
+
 // Save a new shell link
 static
 HRESULT			// status: test using FAILED or SUCCEEDED macro
@@ -347,20 +511,12 @@ JShortcutSave(		// Save a shortcut
 	const int iconIndex	// Index of icon within the icon file
 )
 {
-	char *errStr = NULL;
+	const char *errStr = NULL;
 	HRESULT h;
 	IShellLink *shellLink = NULL;
 	IPersistFile *persistFile = NULL;
 	TCHAR buf[MAX_PATH+1];
 
-#ifdef _WIN64
-        wchar_t wName[MAX_PATH+1];
-#else
-	WORD wName[MAX_PATH+1];
-#endif
-
-	int id;
-
 	// Initialize the COM library
 	h = CoInitialize(NULL);
 	if (FAILED(h)) {
@@ -382,42 +538,16 @@ JShortcutSave(		// Save a shortcut
 	}
 
 	//Append the shortcut name to the folder
-	buf[0] = 0;
-	if (strlen(folder)+strlen(name)+6 > sizeof(buf)) {
+	if (!JShortcutLinkFileName(buf,sizeof(buf),folder,name,NULL)) {
 		errStr = "Folder+name is too long";
 		goto err;
 	}
-	strcat(buf,folder);
-	strcat(buf,"\\");
-	strcat(buf,name);
-	strcat(buf,".lnk");
-	MultiByteToWideChar(CP_ACP,0,buf,-1,wName,MAX_PATH);
 
-	// Load the file if it exists, to get the values for anything
-	// that we do not set.  Ignore errors, such as if it does not exist.
-	h = persistFile->Load(wName, 0);
-
-	// Set the fields for which the application has set a value
-	if (description!=NULL)
-		shellLink->SetDescription(description);
-	if (path!=NULL)
-		shellLink->SetPath(path);
-	if (args!=NULL)
-		shellLink->SetArguments(args);
-	if (workingDir!=NULL)
-		shellLink->SetWorkingDirectory(workingDir);
-	if (iconLoc!=NULL)
-		shellLink->SetIconLocation(iconLoc,iconIndex);
-
-	//One example elsewhere adds this line:
-	//shellLink->SetShowCommand(SW_SHOW);
-
-	//Save the shortcut to disk
-	h = persistFile->Save(wName, TRUE);
-	if (FAILED(h)) {
-		errStr = "Failed to save shortcut";
+	h = JShortcutSaveLink(shellLink,persistFile,buf,buf,
+			description,path,args,workingDir,iconLoc,iconIndex,
+			&errStr);
+	if (FAILED(h))
 		goto err;
-	}
 
 	persistFile->Release();
 	shellLink->Release();
@@ -435,10 +565,14 @@ err:
 	return h;
 }
 
-// Load an existing shell link
+// Load an existing shell link using an already-created IShellLink.
+// This lets callers which load many shortcuts (such as the snapshot
+// exporter) initialize COM and create the IShellLink only once.
 static
 HRESULT			// status: test using FAILED or SUCCEEDED macro
-JShortcutLoad(		// Load a shortcut
+JShortcutLoadLink(	// Load a shortcut into an existing IShellLink
+	IShellLink *shellLink,
+	IPersistFile *persistFile,	// IPersistFile of shellLink
 	const char *folder,	// The directory in which to create the shortcut
 	const char *name,	// Base name of the shortcut
 	char *description,	// RETURN Description of the shortcut
@@ -455,10 +589,9 @@ JShortcutLoad(		// Load a shortcut
 		//All returned chars are written into the caller's buffers
 )
 {
-	char *errStr = NULL;
+	const char *errStr = NULL;
 	HRESULT h;
-	IShellLink *shellLink = NULL;
-	IPersistFile *persistFile = NULL;
+	HANDLE hFile;
 	TCHAR buf[MAX_PATH+1];
 #ifdef _WIN64
         wchar_t wName[MAX_PATH+1];
@@ -466,40 +599,28 @@ JShortcutLoad(		// Load a shortcut
 	WORD wName[MAX_PATH+1];
 #endif
 
-	// Initialize the COM library
-	h = CoInitialize(NULL);
-	if (FAILED(h)) {
-		errStr = "Failed to initialize COM library";
-		goto err;
-	}
-
-	h = CoCreateInstance( CLSID_ShellLink, NULL, CLSCTX_INPROC_SERVER,
-			IID_IShellLink, (PVOID*)&shellLink );
-	if (FAILED(h)) {
-		errStr = "Failed to create IShellLink";
-		goto err;
-	}
-
-	h = shellLink->QueryInterface(IID_IPersistFile, (PVOID*)&persistFile);
-	if (FAILED(h)) {
-		errStr = "Failed to get IPersistFile";
-		goto err;
-	}
-
 	//Append the shortcut name to the folder
-	buf[0] = 0;
-	if (strlen(folder)+strlen(name)+6 > sizeof(buf)) {
+	if (!JShortcutLinkFileName(buf,sizeof(buf),folder,name,NULL)) {
 		errStr = "Folder+name is too long";
+		h = E_INVALIDARG;
 		goto err;
 	}
-	strcat(buf,folder);
-	strcat(buf,"\\");
-	strcat(buf,name);
-	strcat(buf,".lnk");
 	MultiByteToWideChar(CP_ACP,0,buf,-1,wName,MAX_PATH);
 
+	//Check the file before letting the shell parse it
+	errStr = JShortcutValidateLinkFile(buf,&hFile);
+	if (errStr) {
+		if (errStr==JShortcutLinkNotFound ||
+		    errStr==JShortcutLinkCantOpen)
+			h = HRESULT_FROM_WIN32(GetLastError());
+		else
+			h = HRESULT_FROM_WIN32(ERROR_BAD_FORMAT);
+		goto err;
+	}
+
 	//Load the shortcut From disk
 	h = persistFile->Load(wName, 0);
+	CloseHandle(hFile);
 	if (FAILED(h)) {
 		errStr = "Failed to load shortcut";
 		goto err;
@@ -536,6 +657,66 @@ JShortcutLoad(		// Load a shortcut
 		goto err;
 	}
 
+	return h;
+
+err:
+	fprintf(stderr,"Error: %s\n",errStr);
+	//TBD - throw exception with errStr
+	return h;
+}
+
+// Load an existing shell link
+static
+HRESULT			// status: test using FAILED or SUCCEEDED macro
+JShortcutLoad(		// Load a shortcut
+	const char *folder,	// The directory in which to create the shortcut
+	const char *name,	// Base name of the shortcut
+	char *description,	// RETURN Description of the shortcut
+	const int descriptionSize,
+	char *path,		// RETURN Path to the target of the link
+	const int pathSize,
+	char *args,		// RETURN Path to the target of the link
+	const int argsSize,
+	char *workingDir,	// RETURN Working directory for the shortcut
+	const int workingDirSize,
+	char *iconLoc,		// RETURN Icon location
+	const int iconLocSize,
+	int *iconIndex		// RETURN Icon index
+		//All returned chars are written into the caller's buffers
+)
+{
+	char *errStr = NULL;
+	HRESULT h;
+	IShellLink *shellLink = NULL;
+	IPersistFile *persistFile = NULL;
+
+	// Initialize the COM library
+	h = CoInitialize(NULL);
+	if (FAILED(h)) {
+		errStr = "Failed to initialize COM library";
+		goto err;
+	}
+
+	h = CoCreateInstance( CLSID_ShellLink, NULL, CLSCTX_INPROC_SERVER,
+			IID_IShellLink, (PVOID*)&shellLink );
+	if (FAILED(h)) {
+		errStr = "Failed to create IShellLink";
+		goto err;
+	}
+
+	h = shellLink->QueryInterface(IID_IPersistFile, (PVOID*)&persistFile);
+	if (FAILED(h)) {
+		errStr = "Failed to get IPersistFile";
+		goto err;
+	}
+
+	h = JShortcutLoadLink(shellLink,persistFile,folder,name,
+			description,descriptionSize,
+			path,pathSize,
+			args,argsSize,
+			workingDir,workingDirSize,
+			iconLoc,iconLocSize,iconIndex);
+
 	persistFile->Release();
 	shellLink->Release();
 	CoUninitialize();
@@ -552,6 +733,303 @@ err:
 	return h;
 }
 
+// Snapshot export.
+//
+// A snapshot is a compact columnar dump of many shortcuts which can be
+// memory-mapped and read in place, with no parsing step.  All integers are
+// little-endian, and every section starts on an 8-byte boundary.
+//
+//   Header (24 bytes):
+//	char   magic[4]		"JSCS"
+//	UINT32 version		JSHORTCUT_SNAP_VERSION
+//	UINT32 rowCount
+//	UINT32 columnCount
+//	UINT32 codePage		Windows code page of all strings
+//	UINT32 reserved		zero
+//   Column data sections, in any order, located via the footer.
+//   Footer: columnCount column descriptors (32 bytes each):
+//	UINT32 type		JSHORTCUT_SNAP_STRING or JSHORTCUT_SNAP_INT32
+//	UINT32 dictCount	number of distinct strings (0 for INT32)
+//	UINT64 valuesOffset	UINT32 dictionary codes or INT32 values,
+//				one per row
+//	UINT64 dictOffsetsOffset UINT32[dictCount+1] byte offsets of each
+//				string within the dictionary bytes
+//	UINT64 dictBytesOffset	the dictionary strings, each NUL-terminated
+//   Trailer (16 bytes, at the end of the file):
+//	UINT64 footerOffset
+//	UINT32 columnCount
+//	char   magic[4]		"JSCS"
+//
+// The columns are, in order: folder, name, path, workingDirectory,
+// iconLocation (all STRING), iconIndex and status (both INT32).  There is
+// one row for each shortcut the application asked for, in the same order.
+// The status column holds the HRESULT of loading that shortcut:
+//	0		loaded
+//	0x80070002	no such shortcut (ERROR_FILE_NOT_FOUND)
+//	0x8007000B	rejected as malformed (ERROR_BAD_FORMAT)
+//	0x80070057	folder or name not set (E_INVALIDARG)
+//	other		the error from opening the file or from the shell
+// Rows which did not load have only folder and name filled in.
+//
+// Strings are stored in the exporting machine's ANSI code page, which is
+// recorded in codePage.  The path, workingDirectory and iconLocation come
+// from the shell in that code page, and the folder and name are converted
+// to it from the Java strings.  A reader merging snapshots from machines
+// with different code pages must convert using each file's codePage.
+
+#define JSHORTCUT_SNAP_VERSION	1
+#define JSHORTCUT_SNAP_STRING	1
+#define JSHORTCUT_SNAP_INT32	2
+#define JSHORTCUT_SNAP_STRCOLS	5	// folder,name,path,workingDir,iconLoc
+#define JSHORTCUT_SNAP_INTCOLS	2	// iconIndex,status
+
+// A growable array of UINT32 or INT32 values, one per row.
+struct eSnapValues {
+	UINT32 *values;
+	UINT32 count;
+	UINT32 size;
+};
+
+// A dictionary-encoded string column.
+struct eSnapDict {
+	char *bytes;		// the distinct strings, each NUL-terminated
+	UINT32 bytesLen;
+	UINT32 bytesSize;
+	struct eSnapValues offsets;	// offset of each string in bytes
+	UINT32 *table;		// hash table of (dictionary index + 1)
+	UINT32 tableSize;	// always a power of two
+	struct eSnapValues codes;	// dictionary index for each row
+};
+
+// Grow a malloc'ed buffer so that it can hold at least need elements.
+static
+int			// 0 if error, 1 if OK
+JShortcutSnapGrow(
+	void **bufp,		// the buffer to grow, may point to NULL
+	UINT32 *sizep,		// current capacity in elements, updated
+	UINT32 need,		// number of elements required
+	size_t elemSize)
+{
+	UINT32 size;
+	void *buf;
+
+	if (need <= *sizep)
+		return 1;
+	size = *sizep ? *sizep : 64;
+	while (size < need) {
+		if (size > 0x7fffffff)
+			return 0;
+		size *= 2;
+	}
+	if ((size_t)size > ((size_t)-1)/elemSize)
+		return 0;
+	buf = realloc(*bufp,size*elemSize);
+	if (!buf)
+		return 0;
+	*bufp = buf;
+	*sizep = size;
+	return 1;
+}
+
+static
+int			// 0 if error, 1 if OK
+JShortcutSnapAddValue(
+	struct eSnapValues *vals,
+	UINT32 value)
+{
+	if (!JShortcutSnapGrow((void**)&vals->values,&vals->size,
+			vals->count+1,sizeof(UINT32)))
+		return 0;
+	vals->values[vals->count++] = value;
+	return 1;
+}
+
+// Add one row to a string column, adding the string to the column's
+// dictionary if it is not already there.
+static
+int			// 0 if error, 1 if OK
+JShortcutSnapAddString(
+	struct eSnapDict *dict,
+	const char *str)
+{
+	UINT32 hash = 2166136261u;	// FNV-1a
+	UINT32 len, mask, slot, i, code;
+	const char *p;
+
+	if (!str)
+		str = "";
+	for (p=str; *p; p++) {
+		hash ^= (unsigned char)*p;
+		hash *= 16777619u;
+	}
+	len = (UINT32)(p - str);
+
+	// Keep the hash table at most half full.
+	if (dict->offsets.count*2 >= dict->tableSize) {
+		UINT32 newSize = dict->tableSize ? dict->tableSize*2 : 256;
+		UINT32 *newTable = (UINT32*)calloc(newSize,sizeof(UINT32));
+		if (!newTable)
+			return 0;
+		for (i=0; i<dict->offsets.count; i++) {
+			UINT32 h = 2166136261u;
+			for (p=dict->bytes+dict->offsets.values[i]; *p; p++) {
+				h ^= (unsigned char)*p;
+				h *= 16777619u;
+			}
+			slot = h & (newSize-1);
+			while (newTable[slot])
+				slot = (slot+1) & (newSize-1);
+			newTable[slot] = i+1;
+		}
+		free(dict->table);
+		dict->table = newTable;
+		dict->tableSize = newSize;
+	}
+
+	mask = dict->tableSize-1;
+	slot = hash & mask;
+	while (dict->table[slot]) {
+		code = dict->table[slot]-1;
+		if (strcmp(dict->bytes+dict->offsets.values[code],str)==0)
+			return JShortcutSnapAddValue(&dict->codes,code);
+		slot = (slot+1) & mask;
+	}
+
+	// Not found, add it to the dictionary.
+	if (len+1 > 0xffffffffu - dict->bytesLen)
+		return 0;		// dictionary offsets are 32 bits
+	if (!JShortcutSnapGrow((void**)&dict->bytes,&dict->bytesSize,
+			dict->bytesLen+len+1,1))
+		return 0;
+	code = dict->offsets.count;
+	if (!JShortcutSnapAddValue(&dict->offsets,dict->bytesLen))
+		return 0;
+	memcpy(dict->bytes+dict->bytesLen,str,len+1);
+	dict->bytesLen += len+1;
+	dict->table[slot] = code+1;
+	return JShortcutSnapAddValue(&dict->codes,code);
+}
+
+static
+void
+JShortcutSnapFreeDict(
+	struct eSnapDict *dict)
+{
+	free(dict->bytes);
+	free(dict->offsets.values);
+	free(dict->table);
+	free(dict->codes.values);
+}
+
+// Write bytes to the snapshot file, keeping track of the file position.
+static
+int			// 0 if error, 1 if OK
+JShortcutSnapWrite(
+	FILE *f,
+	const void *buf,
+	size_t len,
+	UINT64 *posp)		// current file position, updated
+{
+	if (len>0 && fwrite(buf,1,len,f)!=len)
+		return 0;
+	*posp += len;
+	return 1;
+}
+
+// Pad the snapshot file with zeros to the next 8-byte boundary.
+static
+int			// 0 if error, 1 if OK
+JShortcutSnapAlign(
+	FILE *f,
+	UINT64 *posp)		// current file position, updated
+{
+	static const char zeros[8] = { 0 };
+
+	return JShortcutSnapWrite(f,zeros,(size_t)((8 - *posp%8) % 8),posp);
+}
+
+// Write the collected columns out as a snapshot file.
+static
+int			// 0 if error, 1 if OK
+JShortcutSnapWriteFile(
+	const char *fileName,
+	struct eSnapDict *dicts,	// JSHORTCUT_SNAP_STRCOLS string columns
+	struct eSnapValues *ints,	// JSHORTCUT_SNAP_INTCOLS int columns
+	UINT32 rowCount)
+{
+	struct {
+		UINT32 type;
+		UINT32 dictCount;
+		UINT64 valuesOffset;
+		UINT64 dictOffsetsOffset;
+		UINT64 dictBytesOffset;
+	} footer[JSHORTCUT_SNAP_STRCOLS+JSHORTCUT_SNAP_INTCOLS];
+	UINT32 header[6];
+	UINT32 columnCount = JSHORTCUT_SNAP_STRCOLS+JSHORTCUT_SNAP_INTCOLS;
+	UINT64 footerOffset;
+	UINT64 pos = 0;
+	FILE *f;
+	int i;
+	int ok = 1;
+
+	f = fopen(fileName,"wb");
+	if (!f) {
+		fprintf(stderr,"Can't open snapshot file %s\n",fileName);
+		return 0;
+	}
+
+	memcpy(&header[0],"JSCS",4);
+	header[1] = JSHORTCUT_SNAP_VERSION;
+	header[2] = rowCount;
+	header[3] = columnCount;
+	header[4] = GetACP();
+	header[5] = 0;
+	ok = ok && JShortcutSnapWrite(f,header,sizeof(header),&pos);
+
+	memset(footer,0,sizeof(footer));
+	for (i=0; ok && i<JSHORTCUT_SNAP_STRCOLS; i++) {
+		struct eSnapDict *dict = &dicts[i];
+
+		footer[i].type = JSHORTCUT_SNAP_STRING;
+		footer[i].dictCount = dict->offsets.count;
+		footer[i].valuesOffset = pos;
+		ok = ok && JShortcutSnapWrite(f,dict->codes.values,
+				rowCount*sizeof(UINT32),&pos);
+		ok = ok && JShortcutSnapAlign(f,&pos);
+		// offsets[dictCount] is the end of the last string
+		ok = ok && JShortcutSnapAddValue(&dict->offsets,dict->bytesLen);
+		footer[i].dictOffsetsOffset = pos;
+		ok = ok && JShortcutSnapWrite(f,dict->offsets.values,
+				dict->offsets.count*sizeof(UINT32),&pos);
+		ok = ok && JShortcutSnapAlign(f,&pos);
+		footer[i].dictBytesOffset = pos;
+		ok = ok && JShortcutSnapWrite(f,dict->bytes,dict->bytesLen,&pos);
+		ok = ok && JShortcutSnapAlign(f,&pos);
+	}
+
+	for (i=0; ok && i<JSHORTCUT_SNAP_INTCOLS; i++) {
+		footer[JSHORTCUT_SNAP_STRCOLS+i].type = JSHORTCUT_SNAP_INT32;
+		footer[JSHORTCUT_SNAP_STRCOLS+i].valuesOffset = pos;
+		ok = ok && JShortcutSnapWrite(f,ints[i].values,
+				rowCount*sizeof(UINT32),&pos);
+		ok = ok && JShortcutSnapAlign(f,&pos);
+	}
+
+	footerOffset = pos;
+	ok = ok && JShortcutSnapWrite(f,footer,sizeof(footer),&pos);
+	ok = ok && JShortcutSnapWrite(f,&footerOffset,sizeof(footerOffset),&pos);
+	ok = ok && JShortcutSnapWrite(f,&columnCount,sizeof(columnCount),&pos);
+	ok = ok && JShortcutSnapWrite(f,"JSCS",4,&pos);
+
+	if (fclose(f)!=0)
+		ok = 0;
+	if (!ok) {
+		fprintf(stderr,"Error writing snapshot file %s\n",fileName);
+		remove(fileName);
+	}
+	return ok;
+}
+
 // Save a shell link (shortcut) from Java.
 JNIEXPORT jboolean JNICALL
 Java_net_jimmc_jshortcut_JShellLink_nSave(
@@ -593,6 +1071,471 @@ Java_net_jimmc_jshortcut_JShellLink_nSave(
 	return SUCCEEDED(h);
 }
 
+// The most threads a batch save uses to write its shortcuts.
+#define JSHORTCUT_BATCH_THREADS	8
+
+// One shortcut in a batch save, with the files used to commit it.
+struct eBatchEntry {
+	char target[MAX_PATH+1];	// the final shortcut file
+	char temp[MAX_PATH+1];		// the new contents, before commit
+	char backup[MAX_PATH+1];	// the old contents, during commit
+	char *description;	// copies of the JShellLink fields,
+	char *path;		// NULL when not set
+	char *args;
+	char *workingDir;
+	char *iconLoc;
+	int iconIndex;
+	HRESULT h;		// result of writing temp
+	const char *errStr;	// description of the error, if any
+	int tempWritten;	// temp has been written
+	int targetExisted;	// backup is a copy of target, else a marker
+	int backedUp;		// backup has been written
+	int committed;		// temp has been moved to target
+};
+
+// The work shared by the threads of a batch save.
+struct eBatch {
+	struct eBatchEntry *entries;
+	int count;
+	int next;		// the next entry to be written
+	int failed;		// an entry failed, stop writing
+	CRITICAL_SECTION lock;	// protects next and failed
+};
+
+static
+int			// 1 if the file or directory exists
+JShortcutFileExists(const char *fileName)
+{
+	return (GetFileAttributes(fileName)!=INVALID_FILE_ATTRIBUTES);
+}
+
+// Force a file which has just been written out to the disk.
+static
+int			// 0 if error, 1 if OK
+JShortcutFlushFile(const char *fileName)
+{
+	HANDLE hFile;
+	BOOL ok;
+
+	hFile = CreateFile(fileName,GENERIC_WRITE,0,NULL,
+			OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
+	if (hFile==INVALID_HANDLE_VALUE)
+		return 0;
+	ok = FlushFileBuffers(hFile);
+	CloseHandle(hFile);
+	return ok!=0;
+}
+
+// Create the empty backup file which marks a shortcut that did not exist
+// before the batch which is committing it.
+static
+int			// 0 if error, 1 if OK
+JShortcutCreateMarkerFile(const char *fileName)
+{
+	HANDLE hFile;
+	BOOL ok;
+
+	hFile = CreateFile(fileName,GENERIC_WRITE,0,NULL,
+			CREATE_NEW,FILE_ATTRIBUTE_NORMAL,NULL);
+	if (hFile==INVALID_HANDLE_VALUE)
+		return 0;
+	ok = FlushFileBuffers(hFile);
+	CloseHandle(hFile);
+	return ok!=0;
+}
+
+static
+int			// 1 if the file is empty
+JShortcutIsMarkerFile(const char *fileName)
+{
+	HANDLE hFile;
+	DWORD size;
+
+	hFile = CreateFile(fileName,GENERIC_READ,FILE_SHARE_READ,NULL,
+			OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
+	if (hFile==INVALID_HANDLE_VALUE)
+		return 0;
+	size = GetFileSize(hFile,NULL);
+	CloseHandle(hFile);
+	return (size==0);
+}
+
+static
+char*			// a malloc'ed copy of the string, NULL if none
+JShortcutCopyString(const char *s)
+{
+	char *copy;
+
+	if (s==NULL)
+		return NULL;
+	copy = (char*)malloc(strlen(s)+1);
+	if (copy)
+		strcpy(copy,s);
+	return copy;
+}
+
+// Undo a partially committed batch save, restoring the original files.
+static
+void
+JShortcutBatchRollback(
+	struct eBatchEntry *entries,
+	int count)
+{
+	int i;
+
+	for (i=count-1; i>=0; i--) {
+		struct eBatchEntry *e = &entries[i];
+
+		if (e->committed) {
+			if (!e->targetExisted) {
+				DeleteFile(e->target);
+			} else if (!MoveFileEx(e->backup,e->target,
+			    MOVEFILE_REPLACE_EXISTING|MOVEFILE_WRITE_THROUGH)) {
+				fprintf(stderr,"Can't restore %s from %s\n",
+					e->target,e->backup);
+				continue;	// keep the backup
+			}
+		}
+		if (e->backedUp)
+			DeleteFile(e->backup);
+		if (e->tempWritten && !e->committed)
+			DeleteFile(e->temp);
+	}
+}
+
+// Clean up after a batch save which was interrupted, e.g. by a crash,
+// and left its temporary and backup files behind.  The temp files are
+// all written before any is committed, so if a temp file is left the
+// batch was not committed completely and is undone by restoring every
+// backup.  Otherwise every shortcut was committed and only the backups
+// are left to be removed.  An empty backup marks a shortcut which did
+// not exist before that batch.
+static
+const char*		// NULL if OK, else a description of the problem
+JShortcutBatchRecover(
+	struct eBatchEntry *entries,
+	int count)
+{
+	int i;
+	int undo = 0;
+
+	for (i=0; i<count; i++) {
+		if (JShortcutFileExists(entries[i].temp))
+			undo = 1;
+	}
+	for (i=0; i<count; i++) {
+		struct eBatchEntry *e = &entries[i];
+
+		if (JShortcutFileExists(e->backup)) {
+			fprintf(stderr,"Recovering %s from an interrupted batch\n",
+				e->target);
+			if (!undo) {
+				// committed, nothing to restore
+			} else if (JShortcutIsMarkerFile(e->backup)) {
+				if (JShortcutFileExists(e->target) &&
+				    !DeleteFile(e->target))
+					return "Can't remove uncommitted shortcut";
+			} else if (!MoveFileEx(e->backup,e->target,
+			    MOVEFILE_REPLACE_EXISTING|MOVEFILE_WRITE_THROUGH)) {
+				return "Can't restore shortcut from backup";
+			}
+			if (JShortcutFileExists(e->backup) &&
+			    !DeleteFile(e->backup))
+				return "Can't remove backup file";
+		}
+		if (JShortcutFileExists(e->temp) && !DeleteFile(e->temp))
+			return "Can't remove temporary file";
+	}
+	return NULL;
+}
+
+// Get the file names and field values for one shortcut in a batch save.
+static
+const char*		// NULL if OK, else a description of the problem
+JShortcutBatchFields(
+	struct eContext *ctx,	// ctx->jobj is the JShellLink
+	struct eBatchEntry *e)	// RETURN the file names and values
+{
+	jobject jFolder, jName, jDesc, jPath, jArgs, jWorkingDir, jIconLoc;
+	const char *folder, *name, *desc, *path, *args, *workingDir, *iconLoc;
+	const char *errStr = NULL;
+
+	folder = JShortcutGetNativeString(ctx,"folder",&jFolder);
+	name = JShortcutGetNativeString(ctx,"name",&jName);
+	desc = JShortcutGetNativeString(ctx,"description",&jDesc);
+	path = JShortcutGetNativeString(ctx,"path",&jPath);
+	args = JShortcutGetNativeString(ctx,"arguments",&jArgs);
+	workingDir = JShortcutGetNativeString(ctx,"workingDirectory",
+							&jWorkingDir);
+	iconLoc = JShortcutGetNativeString(ctx,"iconLocation",&jIconLoc);
+	e->iconIndex = JShortcutGetJavaInt(ctx,"iconIndex");
+
+	if (folder==NULL || name==NULL) {
+		errStr = "Shortcut folder or name not specified";
+	} else if (!JShortcutLinkFileName(e->target,sizeof(e->target),
+			folder,name,NULL) ||
+	    !JShortcutLinkFileName(e->temp,sizeof(e->temp),
+			folder,name,".jshortcut-tmp") ||
+	    !JShortcutLinkFileName(e->backup,sizeof(e->backup),
+			folder,name,".jshortcut-bak")) {
+		errStr = "Folder+name is too long";
+	} else {
+		e->description = JShortcutCopyString(desc);
+		e->path = JShortcutCopyString(path);
+		e->args = JShortcutCopyString(args);
+		e->workingDir = JShortcutCopyString(workingDir);
+		e->iconLoc = JShortcutCopyString(iconLoc);
+		if ((desc && !e->description) || (path && !e->path) ||
+		    (args && !e->args) || (workingDir && !e->workingDir) ||
+		    (iconLoc && !e->iconLoc))
+			errStr = "Out of memory";
+	}
+
+	JShortcutReleaseNativeString(ctx->env,jFolder,folder);
+	JShortcutReleaseNativeString(ctx->env,jName,name);
+	JShortcutReleaseNativeString(ctx->env,jDesc,desc);
+	JShortcutReleaseNativeString(ctx->env,jPath,path);
+	JShortcutReleaseNativeString(ctx->env,jArgs,args);
+	JShortcutReleaseNativeString(ctx->env,jWorkingDir,workingDir);
+	JShortcutReleaseNativeString(ctx->env,jIconLoc,iconLoc);
+	return errStr;
+}
+
+// Write the new version of one shortcut in a batch save to its temp file.
+static
+void
+JShortcutBatchWrite(struct eBatchEntry *e)
+{
+	IShellLink *shellLink = NULL;
+	IPersistFile *persistFile = NULL;
+
+	// A new IShellLink for each shortcut, so that values from the
+	// previous one do not leak into a shortcut which does not yet
+	// exist on disk.
+	e->h = CoCreateInstance(CLSID_ShellLink, NULL,
+			CLSCTX_INPROC_SERVER, IID_IShellLink,
+			(PVOID*)&shellLink);
+	if (FAILED(e->h)) {
+		e->errStr = "Failed to create IShellLink";
+	} else if (FAILED(e->h = shellLink->QueryInterface(
+			IID_IPersistFile, (PVOID*)&persistFile))) {
+		e->errStr = "Failed to get IPersistFile";
+	} else {
+		e->h = JShortcutSaveLink(shellLink,persistFile,
+			e->target,e->temp,e->description,e->path,e->args,
+			e->workingDir,e->iconLoc,e->iconIndex,&e->errStr);
+		// Save may have created the file even if it failed
+		e->tempWritten = 1;
+	}
+	if (persistFile!=NULL)
+		persistFile->Release();
+	if (shellLink!=NULL)
+		shellLink->Release();
+
+	if (SUCCEEDED(e->h) && !JShortcutFlushFile(e->temp)) {
+		e->h = HRESULT_FROM_WIN32(GetLastError());
+		e->errStr = "Failed to flush shortcut";
+	}
+}
+
+// A thread which writes shortcuts of a batch save until none are left
+// or one of them fails.  Each thread has its own COM apartment.
+static
+unsigned __stdcall
+JShortcutBatchWorker(void *arg)
+{
+	struct eBatch *batch = (struct eBatch*)arg;
+	HRESULT hInit;
+	int i;
+
+	hInit = CoInitialize(NULL);
+	for (;;) {
+		struct eBatchEntry *e;
+
+		EnterCriticalSection(&batch->lock);
+		i = batch->failed ? batch->count : batch->next++;
+		LeaveCriticalSection(&batch->lock);
+		if (i>=batch->count)
+			break;
+
+		e = &batch->entries[i];
+		if (FAILED(hInit)) {
+			e->h = hInit;
+			e->errStr = "Failed to initialize COM library";
+		} else {
+			JShortcutBatchWrite(e);
+		}
+		if (FAILED(e->h)) {
+			EnterCriticalSection(&batch->lock);
+			batch->failed = 1;
+			LeaveCriticalSection(&batch->lock);
+		}
+	}
+	if (SUCCEEDED(hInit))
+		CoUninitialize();
+	return 0;
+}
+
+// Save a set of shell links (shortcuts) from Java as a single transaction.
+// Every shortcut is first written to a temporary file next to its final
+// location, spread over a few threads.  Only when all of them have been
+// written and flushed are they renamed over the final files, keeping a
+// copy of each existing shortcut as a backup until the whole set is in
+// place, so a shortcut file is never missing.  If anything fails, all of
+// the new files are removed and the original shortcuts are restored.
+// The batch is refused before anything is written if it names the same
+// shortcut twice.  Files left by an interrupted save of the same
+// shortcuts are cleaned up first, see JShortcutBatchRecover.
+JNIEXPORT jboolean JNICALL
+Java_net_jimmc_jshortcut_JShellLink_nSaveBatch(
+	JNIEnv *env,
+	jclass jcl,		// static method
+	jobjectArray jLinks)	// JShellLink[] to save
+{
+	struct eBatchEntry *entries = NULL;
+	struct eBatch batch;
+	HANDLE threads[JSHORTCUT_BATCH_THREADS];
+	int threadCount = 0;
+	jsize count, i, j;
+	const char *errStr = NULL;
+	int ok = 0;
+	struct eContext ctx;
+
+	JShortcutInitContext(&ctx,env,NULL);
+
+	if (jLinks==NULL || !JShortcutFindClasses(&ctx))
+		return false;		//error, incompletely specified
+	count = env->GetArrayLength(jLinks);
+	if (count==0)
+		return true;
+	entries = (struct eBatchEntry*)calloc(count,sizeof(*entries));
+	if (!entries)
+		return false;
+
+	// Get everything from Java and check the file names before writing
+	// anything, so that a bad batch leaves no trace.  The threads which
+	// write the shortcuts can not use this JNIEnv.
+	for (i=0; i<count; i++) {
+		struct eBatchEntry *e = &entries[i];
+
+		if (env->PushLocalFrame(32)!=0) {
+			errStr = "Out of memory";
+			goto done;
+		}
+		ctx.jobj = env->GetObjectArrayElement(jLinks,i);
+		if (ctx.jobj)
+			errStr = JShortcutBatchFields(&ctx,e);
+		else
+			errStr = "Null shortcut in batch";
+		env->PopLocalFrame(NULL);
+		ctx.jobj = NULL;
+		if (errStr)
+			goto done;
+
+		for (j=0; j<i; j++) {
+			if (lstrcmpi(entries[j].target,e->target)==0) {
+				fprintf(stderr,"Duplicate shortcut %s\n",
+					e->target);
+				errStr = "Same shortcut appears twice in batch";
+				goto done;
+			}
+		}
+	}
+
+	errStr = JShortcutBatchRecover(entries,count);
+	if (errStr)
+		goto done;
+
+	// Write the new version of each shortcut to its temp file.
+	batch.entries = entries;
+	batch.count = count;
+	batch.next = 0;
+	batch.failed = 0;
+	InitializeCriticalSection(&batch.lock);
+	while (threadCount<JSHORTCUT_BATCH_THREADS && threadCount<count) {
+		HANDLE hThread = (HANDLE)_beginthreadex(NULL,0,
+				JShortcutBatchWorker,&batch,0,NULL);
+		if (hThread==0)
+			break;
+		threads[threadCount++] = hThread;
+	}
+	if (threadCount==0) {
+		// No threads to be had, do it all here instead
+		JShortcutBatchWorker(&batch);
+	} else {
+		WaitForMultipleObjects(threadCount,threads,TRUE,INFINITE);
+		for (i=0; i<threadCount; i++)
+			CloseHandle(threads[i]);
+	}
+	DeleteCriticalSection(&batch.lock);
+
+	if (batch.failed) {
+		for (i=0; i<count; i++) {
+			if (FAILED(entries[i].h)) {
+				fprintf(stderr,"Can't write %s\n",
+					entries[i].target);
+				errStr = entries[i].errStr;
+				break;
+			}
+		}
+		goto rollback;
+	}
+
+	// Everything is written, now move the new files into place.  The
+	// existing shortcut is copied rather than moved to its backup, so
+	// that the target is replaced in one step and is never missing.
+	for (i=0; i<count; i++) {
+		struct eBatchEntry *e = &entries[i];
+
+		e->targetExisted = JShortcutFileExists(e->target);
+		if (e->targetExisted) {
+			if (!CopyFile(e->target,e->backup,TRUE)) {
+				errStr = "Failed to back up existing shortcut";
+				goto rollback;
+			}
+			e->backedUp = 1;
+			if (!JShortcutFlushFile(e->backup)) {
+				errStr = "Failed to flush backup";
+				goto rollback;
+			}
+		} else {
+			if (!JShortcutCreateMarkerFile(e->backup)) {
+				errStr = "Failed to create backup marker";
+				goto rollback;
+			}
+			e->backedUp = 1;
+		}
+		if (!MoveFileEx(e->temp,e->target,
+		    MOVEFILE_REPLACE_EXISTING|MOVEFILE_WRITE_THROUGH)) {
+			errStr = "Failed to rename shortcut into place";
+			goto rollback;
+		}
+		e->committed = 1;
+	}
+
+	// The whole set is in place, the backups are no longer needed.
+	for (i=0; i<count; i++)
+		DeleteFile(entries[i].backup);
+	ok = 1;
+	goto done;
+
+rollback:
+	JShortcutBatchRollback(entries,count);
+
+done:
+	if (errStr)
+		fprintf(stderr,"Error: %s\n",errStr);
+	for (i=0; i<count; i++) {
+		free(entries[i].description);
+		free(entries[i].path);
+		free(entries[i].args);
+		free(entries[i].workingDir);
+		free(entries[i].iconLoc);
+	}
+	free(entries);
+	return ok;
+}
+
 // Load a shell link (shortcut) from Java.
 JNIEXPORT jboolean JNICALL
 Java_net_jimmc_jshortcut_JShellLink_nLoad(
@@ -715,4 +1658,132 @@ Java_net_jimmc_jshortcut_JShellLink_nGetDirectory(
 	return jstr;
 }
 
+// Export a columnar snapshot of a set of shell links from Java.
+JNIEXPORT jboolean JNICALL
+Java_net_jimmc_jshortcut_JShellLink_nExportSnapshot(
+	JNIEnv *env,
+	jclass jcl,		// static method
+	jobjectArray jLinks,	// JShellLink[], only folder and name are used
+	jstring jFile)		// the snapshot file to write
+{
+	jobject jFileObj;
+	const char *fileName;
+	char folder[MAX_PATH+1];
+	char name[MAX_PATH+1];
+	char desc[MAX_PATH+1];
+	char path[MAX_PATH+1];
+	char args[MAX_PATH+1];
+	char workingDir[MAX_PATH+1];
+	char iconLoc[MAX_PATH+1];
+	int iconIndex;
+	struct eSnapDict dicts[JSHORTCUT_SNAP_STRCOLS];
+	struct eSnapValues ints[JSHORTCUT_SNAP_INTCOLS];
+	jsize count, i;
+	IShellLink *shellLink = NULL;
+	IPersistFile *persistFile = NULL;
+	char *errStr = NULL;
+	HRESULT h;
+	int ok = 0;
+	struct eContext ctx;
+
+	JShortcutInitContext(&ctx,env,NULL);
+	memset(dicts,0,sizeof(dicts));
+	memset(ints,0,sizeof(ints));
+
+	if (jLinks==NULL || !JShortcutFindClasses(&ctx))
+		return false;		//error, incompletely specified
+	fileName = JShortcutJavaStringToNative(&ctx,jFile,&jFileObj);
+	if (fileName==NULL)
+		return false;		//error, incompletely specified
+
+	// Initialize COM and create the IShellLink once for all shortcuts.
+	h = CoInitialize(NULL);
+	if (FAILED(h)) {
+		errStr = "Failed to initialize COM library";
+		goto done;
+	}
+
+	h = CoCreateInstance( CLSID_ShellLink, NULL, CLSCTX_INPROC_SERVER,
+			IID_IShellLink, (PVOID*)&shellLink );
+	if (FAILED(h)) {
+		errStr = "Failed to create IShellLink";
+		goto done;
+	}
+
+	h = shellLink->QueryInterface(IID_IPersistFile, (PVOID*)&persistFile);
+	if (FAILED(h)) {
+		errStr = "Failed to get IPersistFile";
+		goto done;
+	}
+
+	count = env->GetArrayLength(jLinks);
+	for (i=0; i<count; i++) {
+		int haveName = 0;
+
+		// Each row creates several local references; release them
+		// as we go so that large exports do not overflow the table.
+		if (env->PushLocalFrame(16)!=0) {
+			errStr = "Out of memory";
+			goto done;
+		}
+		ctx.jobj = env->GetObjectArrayElement(jLinks,i);
+		folder[0] = name[0] = 0;
+		if (ctx.jobj) {
+			haveName = JShortcutGetAcpString(&ctx,"folder",
+						folder,sizeof(folder)) &&
+				JShortcutGetAcpString(&ctx,"name",
+						name,sizeof(name));
+		}
+		env->PopLocalFrame(NULL);
+		ctx.jobj = NULL;
+
+		// Every row is recorded, with the reason if it did not load.
+		desc[0] = path[0] = args[0] = workingDir[0] = iconLoc[0] = 0;
+		iconIndex = 0;
+		if (!haveName) {
+			h = E_INVALIDARG;
+		} else {
+			h = JShortcutLoadLink(shellLink,persistFile,
+				folder,name,
+				desc,sizeof(desc),
+				path,sizeof(path),
+				args,sizeof(args),
+				workingDir,sizeof(workingDir),
+				iconLoc,sizeof(iconLoc),&iconIndex);
+			if (FAILED(h)) {
+				desc[0] = path[0] = args[0] = 0;
+				workingDir[0] = iconLoc[0] = 0;
+				iconIndex = 0;
+			}
+		}
+		if (!JShortcutSnapAddString(&dicts[0],folder) ||
+		    !JShortcutSnapAddString(&dicts[1],name) ||
+		    !JShortcutSnapAddString(&dicts[2],path) ||
+		    !JShortcutSnapAddString(&dicts[3],workingDir) ||
+		    !JShortcutSnapAddString(&dicts[4],iconLoc) ||
+		    !JShortcutSnapAddValue(&ints[0],(UINT32)iconIndex) ||
+		    !JShortcutSnapAddValue(&ints[1],(UINT32)h)) {
+			errStr = "Out of memory";
+			goto done;
+		}
+	}
+
+	ok = JShortcutSnapWriteFile(fileName,dicts,ints,(UINT32)count);
+
+done:
+	if (persistFile!=NULL)
+		persistFile->Release();
+	if (shellLink!=NULL)
+		shellLink->Release();
+	CoUninitialize();
+	if (errStr)
+		fprintf(stderr,"Error: %s\n",errStr);
+	for (i=0; i<JSHORTCUT_SNAP_STRCOLS; i++)
+		JShortcutSnapFreeDict(&dicts[i]);
+	for (i=0; i<JSHORTCUT_SNAP_INTCOLS; i++)
+		free(ints[i].values);
+	JShortcutReleaseNativeString(env,jFileObj,fileName);
+	return ok;
+}
+
 } // extern "C"
\ No newline at end of file
@@ -0,0 +1,339 @@
+/* Copyright 2026 the JShortcut contributors under GNU LGPL v2.1 */
+
+// Validation of shortcut (.lnk) file contents; see lnkcheck.h.
+
+#include <string.h>
+#include "lnkcheck.h"
+
+// LinkFlags
+#define JSHORTCUT_HAS_ID_LIST		0x00000001
+#define JSHORTCUT_HAS_LINK_INFO		0x00000002
+#define JSHORTCUT_HAS_NAME		0x00000004
+#define JSHORTCUT_HAS_RELATIVE_PATH	0x00000008
+#define JSHORTCUT_HAS_WORKING_DIR	0x00000010
+#define JSHORTCUT_HAS_ARGUMENTS		0x00000020
+#define JSHORTCUT_HAS_ICON_LOCATION	0x00000040
+#define JSHORTCUT_IS_UNICODE		0x00000080
+
+// LinkInfoFlags
+#define JSHORTCUT_VOLUME_ID_AND_LOCAL_BASE_PATH	0x00000001
+#define JSHORTCUT_COMMON_NETWORK_RELATIVE_LINK	0x00000002
+
+// CommonNetworkRelativeLinkFlags
+#define JSHORTCUT_VALID_DEVICE		0x00000001
+
+// 00021401-0000-0000-C000-000000000046
+static const unsigned char JShortcutLinkCLSID[16] = {
+	0x01, 0x14, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46
+};
+
+// ExtraData blocks which always have the same size.
+static const struct {
+	unsigned int signature;
+	unsigned int size;
+} JShortcutFixedBlocks[] = {
+	{ 0xA0000001, 0x314 },	// EnvironmentVariableDataBlock
+	{ 0xA0000002, 0xCC },	// ConsoleDataBlock
+	{ 0xA0000003, 0x60 },	// TrackerDataBlock
+	{ 0xA0000004, 0x0C },	// ConsoleFEDataBlock
+	{ 0xA0000005, 0x10 },	// SpecialFolderDataBlock
+	{ 0xA0000006, 0x314 },	// DarwinDataBlock
+	{ 0xA0000007, 0x314 },	// IconEnvironmentDataBlock
+	{ 0xA000000B, 0x1C },	// KnownFolderDataBlock
+};
+
+static
+unsigned int
+JShortcutGet16(
+	const unsigned char *p)
+{
+	return (unsigned int)p[0] | ((unsigned int)p[1]<<8);
+}
+
+static
+unsigned int
+JShortcutGet32(
+	const unsigned char *p)
+{
+	return (unsigned int)p[0] | ((unsigned int)p[1]<<8) |
+		((unsigned int)p[2]<<16) | ((unsigned int)p[3]<<24);
+}
+
+// Check that a NUL-terminated string lies entirely within a structure.
+static
+int			// 0 if bad, 1 if OK
+JShortcutCheckLinkString(
+	const unsigned char *base,	// start of the containing structure
+	unsigned int size,			// size of the containing structure
+	unsigned int offset,			// offset of the string within it
+	int unicode)			// 1 for a UTF-16 string
+{
+	unsigned int i;
+
+	if (unicode) {
+		for (i=offset; i<size && size-i>=2; i+=2) {
+			if (base[i]==0 && base[i+1]==0)
+				return 1;
+		}
+	} else {
+		for (i=offset; i<size; i++) {
+			if (base[i]==0)
+				return 1;
+		}
+	}
+	return 0;
+}
+
+// Check the LinkInfo structure, which holds the target's volume and path.
+static
+const char*		// NULL if OK, else a description of the problem
+JShortcutValidateLinkInfo(
+	const unsigned char *info,
+	unsigned int infoSize)	// already checked against the file length
+{
+	unsigned int headerSize, flags, off, size, nameOff;
+	const unsigned char *p;
+
+	if (infoSize < 0x1C)
+		return "LinkInfo too small";
+	headerSize = JShortcutGet32(info+4);
+	if (headerSize!=0x1C && (headerSize<0x24 || headerSize>infoSize))
+		return "Bad LinkInfoHeaderSize";
+	flags = JShortcutGet32(info+8);
+
+	if (flags & JSHORTCUT_VOLUME_ID_AND_LOCAL_BASE_PATH) {
+		off = JShortcutGet32(info+12);		// VolumeIDOffset
+		if (off > infoSize || infoSize-off < 0x10)
+			return "Bad VolumeIDOffset";
+		p = info+off;
+		size = JShortcutGet32(p);		// VolumeIDSize
+		if (size <= 0x10 || size > infoSize-off)
+			return "Bad VolumeIDSize";
+		nameOff = JShortcutGet32(p+12);		// VolumeLabelOffset
+		if (nameOff==0x14) {
+			if (size < 0x14)
+				return "Bad VolumeIDSize";
+			nameOff = JShortcutGet32(p+16);
+			if (!JShortcutCheckLinkString(p,size,nameOff,1))
+				return "Bad VolumeLabelOffsetUnicode";
+		} else if (!JShortcutCheckLinkString(p,size,nameOff,0)) {
+			return "Bad VolumeLabelOffset";
+		}
+		if (!JShortcutCheckLinkString(info,infoSize,
+				JShortcutGet32(info+16),0))
+			return "Bad LocalBasePathOffset";
+		if (headerSize>=0x24 && JShortcutGet32(info+28)!=0 &&
+		    !JShortcutCheckLinkString(info,infoSize,
+				JShortcutGet32(info+28),1))
+			return "Bad LocalBasePathOffsetUnicode";
+	}
+
+	if (flags & JSHORTCUT_COMMON_NETWORK_RELATIVE_LINK) {
+		unsigned int netFlags;
+
+		off = JShortcutGet32(info+20);	// CommonNetworkRelativeLinkOffset
+		if (off > infoSize || infoSize-off < 0x14)
+			return "Bad CommonNetworkRelativeLinkOffset";
+		p = info+off;
+		size = JShortcutGet32(p);
+		if (size < 0x14 || size > infoSize-off)
+			return "Bad CommonNetworkRelativeLinkSize";
+		netFlags = JShortcutGet32(p+4);
+		nameOff = JShortcutGet32(p+8);		// NetNameOffset
+		if (!JShortcutCheckLinkString(p,size,nameOff,0))
+			return "Bad NetNameOffset";
+		if ((netFlags & JSHORTCUT_VALID_DEVICE) &&
+		    !JShortcutCheckLinkString(p,size,JShortcutGet32(p+12),0))
+			return "Bad DeviceNameOffset";
+		if (nameOff > 0x14) {
+			if (size < 0x1C)
+				return "Bad CommonNetworkRelativeLinkSize";
+			if (!JShortcutCheckLinkString(p,size,
+					JShortcutGet32(p+20),1))
+				return "Bad NetNameOffsetUnicode";
+			if ((netFlags & JSHORTCUT_VALID_DEVICE) &&
+			    !JShortcutCheckLinkString(p,size,
+					JShortcutGet32(p+24),1))
+				return "Bad DeviceNameOffsetUnicode";
+		}
+	}
+
+	if (!JShortcutCheckLinkString(info,infoSize,JShortcutGet32(info+24),0))
+		return "Bad CommonPathSuffixOffset";
+	if (headerSize>=0x24 && JShortcutGet32(info+32)!=0 &&
+	    !JShortcutCheckLinkString(info,infoSize,JShortcutGet32(info+32),1))
+		return "Bad CommonPathSuffixOffsetUnicode";
+
+	return NULL;
+}
+
+// Check that the contents of a shortcut file are well-formed.
+const char*		// NULL if OK, else a description of the problem
+JShortcutValidateLink(
+	const unsigned char *data,	// the contents of the file
+	unsigned int len)			// the length of the file
+{
+	static const unsigned int stringFlags[] = {
+		JSHORTCUT_HAS_NAME, JSHORTCUT_HAS_RELATIVE_PATH,
+		JSHORTCUT_HAS_WORKING_DIR, JSHORTCUT_HAS_ARGUMENTS,
+		JSHORTCUT_HAS_ICON_LOCATION
+	};
+	unsigned int flags, pos, size, i;
+	const char *errStr;
+
+	// ShellLinkHeader
+	if (len < JSHORTCUT_LINK_HEADER_SIZE)
+		return "Truncated header";
+	if (JShortcutGet32(data)!=JSHORTCUT_LINK_HEADER_SIZE)
+		return "Bad HeaderSize";
+	if (memcmp(data+4,JShortcutLinkCLSID,sizeof(JShortcutLinkCLSID))!=0)
+		return "Bad LinkCLSID";
+	flags = JShortcutGet32(data+20);
+	pos = JSHORTCUT_LINK_HEADER_SIZE;
+
+	// LinkTargetIDList: a list of ItemIDs ending with a zero TerminalID
+	if (flags & JSHORTCUT_HAS_ID_LIST) {
+		unsigned int end;
+
+		if (len-pos < 2)
+			return "Truncated IDList";
+		size = JShortcutGet16(data+pos);	// IDListSize
+		pos += 2;
+		if (size > len-pos)
+			return "Bad IDListSize";
+		end = pos+size;
+		for (;;) {
+			unsigned int itemSize;
+
+			if (end-pos < 2)
+				return "Missing IDList TerminalID";
+			itemSize = JShortcutGet16(data+pos);
+			if (itemSize==0) {
+				if (end-pos != 2)
+					return "Bad IDListSize";
+				break;
+			}
+			if (itemSize < 2 || itemSize > end-pos)
+				return "Bad ItemIDSize";
+			pos += itemSize;
+		}
+		pos = end;
+	}
+
+	// LinkInfo
+	if (flags & JSHORTCUT_HAS_LINK_INFO) {
+		if (len-pos < 4)
+			return "Truncated LinkInfo";
+		size = JShortcutGet32(data+pos);	// LinkInfoSize
+		if (size > len-pos)
+			return "Bad LinkInfoSize";
+		errStr = JShortcutValidateLinkInfo(data+pos,size);
+		if (errStr)
+			return errStr;
+		pos += size;
+	}
+
+	// StringData: a count of characters followed by the characters
+	for (i=0; i<sizeof(stringFlags)/sizeof(stringFlags[0]); i++) {
+		if (!(flags & stringFlags[i]))
+			continue;
+		if (len-pos < 2)
+			return "Truncated StringData";
+		size = JShortcutGet16(data+pos);	// CountCharacters
+		pos += 2;
+		if (flags & JSHORTCUT_IS_UNICODE)
+			size *= 2;
+		if (size > len-pos)
+			return "Bad StringData CountCharacters";
+		pos += size;
+	}
+
+	// ExtraData: a list of blocks ending with a TerminalBlock
+	while (len-pos >= 4) {
+		unsigned int signature;
+
+		size = JShortcutGet32(data+pos);	// BlockSize
+		if (size < 4)
+			return NULL;		// TerminalBlock
+		if (size < 8 || size > len-pos)
+			return "Bad ExtraData BlockSize";
+		signature = JShortcutGet32(data+pos+4);
+		for (i=0; i<sizeof(JShortcutFixedBlocks)/
+				sizeof(JShortcutFixedBlocks[0]); i++) {
+			if (JShortcutFixedBlocks[i].signature==signature &&
+			    JShortcutFixedBlocks[i].size!=size)
+				return "Bad ExtraData BlockSize";
+		}
+		pos += size;
+	}
+	if (pos!=len)
+		return "Truncated ExtraData";
+	return NULL;
+}
+
+#ifdef _WIN32
+#ifndef INVALID_FILE_SIZE
+#define INVALID_FILE_SIZE ((DWORD)-1)	//not in older SDKs
+#endif
+
+const char JShortcutLinkNotFound[] = "Shortcut not found";
+const char JShortcutLinkCantOpen[] = "Can't open shortcut";
+
+const char*
+JShortcutValidateLinkFile(
+	const char *fileName,
+	HANDLE *hFilep)
+{
+	HANDLE hFile, hMap;
+	DWORD size, sizeHigh;
+	const unsigned char *data;
+	const char *errStr;
+
+	*hFilep = INVALID_HANDLE_VALUE;
+	hFile = CreateFile(fileName,GENERIC_READ,FILE_SHARE_READ,NULL,
+			OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
+	if (hFile==INVALID_HANDLE_VALUE) {
+		if (GetLastError()==ERROR_FILE_NOT_FOUND)
+			return JShortcutLinkNotFound;
+		return JShortcutLinkCantOpen;
+	}
+	// GetFileSize rather than GetFileSizeEx, which needs Windows 2000
+	size = GetFileSize(hFile,&sizeHigh);
+	if (size==INVALID_FILE_SIZE && GetLastError()!=NO_ERROR) {
+		CloseHandle(hFile);
+		return "Can't get shortcut size";
+	}
+	if (sizeHigh!=0 || size > JSHORTCUT_MAX_LINK_SIZE) {
+		CloseHandle(hFile);
+		return "Shortcut file is too large";
+	}
+	if (size < JSHORTCUT_LINK_HEADER_SIZE) {
+		CloseHandle(hFile);
+		return "Truncated header";
+	}
+
+	hMap = CreateFileMapping(hFile,NULL,PAGE_READONLY,0,0,NULL);
+	if (hMap==NULL) {
+		CloseHandle(hFile);
+		return "Can't map shortcut";
+	}
+	data = (const unsigned char*)MapViewOfFile(hMap,FILE_MAP_READ,0,0,0);
+	if (data==NULL) {
+		CloseHandle(hMap);
+		CloseHandle(hFile);
+		return "Can't map shortcut";
+	}
+
+	errStr = JShortcutValidateLink(data,size);
+
+	UnmapViewOfFile(data);
+	CloseHandle(hMap);
+	if (errStr) {
+		CloseHandle(hFile);
+		return errStr;
+	}
+	*hFilep = hFile;
+	return NULL;
+}
+#endif /* _WIN32 */
@@ -0,0 +1,47 @@
+/* Copyright 2026 the JShortcut contributors under GNU LGPL v2.1 */
+
+#ifndef LNKCHECK_H
+#define LNKCHECK_H
+
+// Shortcut file validation.
+//
+// Shortcut files may come from untrusted places, so before handing one to
+// the shell we check it against the .lnk file format (MS-SHLLINK) in a
+// single pass over a read-only mapping of the file.  Every size and offset
+// is checked against the bytes remaining before it is used, nothing is
+// allocated, and each byte is looked at a bounded number of times, so a
+// malformed file costs at most O(file size) to reject.
+//
+// JShortcutValidateLink has no Windows dependencies, so that it can also
+// be built into the fuzz target and benchmark in the fuzz directory.
+
+// Shortcut files are small; anything larger than this is rejected
+// without looking at it.
+#define JSHORTCUT_MAX_LINK_SIZE	(1024*1024)
+
+#define JSHORTCUT_LINK_HEADER_SIZE	0x4C
+
+// Check that the contents of a shortcut file are well-formed.
+const char*		// NULL if OK, else a description of the problem
+JShortcutValidateLink(
+	const unsigned char *data,	// the contents of the file
+	unsigned int len);		// the length of the file
+
+#ifdef _WIN32
+#include <windows.h>
+
+// Returned by JShortcutValidateLinkFile when the file can not be opened,
+// with the reason available from GetLastError().
+extern const char JShortcutLinkNotFound[];
+extern const char JShortcutLinkCantOpen[];
+
+// Check that a shortcut file is well-formed before the shell loads it.
+// On success the file is left open, which keeps anyone from changing it
+// before the shell reads it; the caller must close the returned handle.
+const char*		// NULL if OK, else a description of the problem
+JShortcutValidateLinkFile(
+	const char *fileName,	// the shortcut file to check
+	HANDLE *hFilep);	// RETURN the open file, if OK
+#endif /* _WIN32 */
+
+#endif /* LNKCHECK_H */
@@ -271,7 +271,11 @@ public class JShellLink {
 	}
     }
 
-    /** Write out this shortcut to disk. */
+    /** Write out this shortcut to disk.
+     * Values which have not been set are kept from the existing
+     * shortcut file, unless that file is malformed or can't be read,
+     * in which case it is replaced by a new shortcut.
+     */
     public void save() {
         if (!nSave()) {
 	    throw new RuntimeException("Failed to save ShellLink");
@@ -279,6 +283,51 @@ public class JShellLink {
 	}
     }
 
+    /** Write out a set of shortcuts to disk as a single transaction.
+     * Either all of the shortcuts are saved, or none of them are and
+     * any existing shortcuts are left as they were.
+     * Each shortcut is first written and flushed to a temporary file
+     * (<i>name</i>.lnk.jshortcut-tmp), on several threads.
+     * Then each existing shortcut is copied to
+     * <i>name</i>.lnk.jshortcut-bak and replaced by its temporary file,
+     * and the backups are removed once the whole set has been committed.
+     * Nothing is written if the same shortcut appears more than once.
+     * If a previous call was interrupted, for example by a crash,
+     * calling saveAll again with the same shortcuts first finishes or
+     * undoes that call using the files it left behind.
+     * @param links The shortcuts to save.
+     */
+    public static void saveAll(JShellLink[] links) {
+        if (!nSaveBatch(links)) {
+	    throw new RuntimeException("Failed to save ShellLinks");
+	    	//TBD - better error info
+	}
+    }
+
+    /** Export a snapshot of a set of shortcuts to a file.
+     * Each shortcut is identified by its folder and name;
+     * no other fields of the JShellLink objects are used.
+     * The snapshot is a compact binary columnar file, with dictionary
+     * encoded folder, name, path, workingDirectory and iconLocation
+     * columns and iconIndex and status columns, which can be
+     * memory-mapped and read without parsing.
+     * There is one row per shortcut, in the order given.
+     * The status column holds the Windows HRESULT from loading the
+     * shortcut, so that a shortcut which does not exist can be told
+     * apart from one which was rejected as malformed.
+     * Strings are written in the ANSI code page of this machine,
+     * and the file header records which code page that is.
+     * See the native code for a description of the file layout.
+     * @param links The shortcuts to export.
+     * @param file The name of the snapshot file to write.
+     */
+    public static void exportSnapshot(JShellLink[] links, String file) {
+        if (!nExportSnapshot(links,file)) {
+	    throw new RuntimeException("Failed to export snapshot");
+	    	//TBD - better error info
+	}
+    }
+
   //Native methods
 
     /** Load a shortcut.
@@ -300,6 +349,17 @@ public class JShellLink {
      */
     private static native String nGetDirectory(String dirtype);
 
+    /** Save a set of shortcuts as a single transaction.
+     * The native code reads the same variables from each object as nSave.
+     */
+    private static native boolean nSaveBatch(JShellLink[] links);
+
+    /** Export a snapshot of a set of shortcuts.
+     * The native code reads the folder and name of each shortcut.
+     */
+    private static native boolean nExportSnapshot(JShellLink[] links,
+    		String file);
+
   //End native methods
 
     public static void main(String argv[] )